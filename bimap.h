@@ -3,19 +3,27 @@
 #include "cartesian_tree.h"
 #include "node.h"
 
+#include <algorithm>
+#include <functional>
+#include <future>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 template <typename Left, typename Right, typename CompareLeft = std::less<Left>,
-          typename CompareRight = std::less<Right>>
+          typename CompareRight = std::less<Right>, bool Hashed = false>
 struct bimap {
 private:
   using left_t = Left;
   using right_t = Right;
-  using node_t = node_details::node_t<left_t, right_t>;
-  using left_node_t = node_details::node_ptr_t<left_t, true>;
+  using node_t = node_details::node_t<left_t, right_t, Hashed>;
+  using left_node_t = node_details::node_ptr_t<left_t, true, Hashed>;
   using right_node_t = node_details::node_ptr_t<right_t, false>;
   using node_base_t = node_details::node_base_t;
-  using left_tree_t = cartesian_tree::treap<left_t, CompareLeft, true>;
+  using left_tree_t =
+      cartesian_tree::treap<left_t, CompareLeft, true, Hashed>;
   using right_tree_t = cartesian_tree::treap<right_t, CompareRight, false>;
   using left_tree_iter = typename left_tree_t::iterator;
   using right_tree_iter = typename right_tree_t::iterator;
@@ -24,6 +32,20 @@ private:
   right_tree_t right_tree;
   std::size_t cnt_elem = 0;
 
+  template <typename T, typename = void>
+  struct is_hashable : std::false_type {};
+  template <typename T>
+  struct is_hashable<
+      T, std::void_t<decltype(std::hash<T>()(std::declval<T const&>()))>>
+      : std::true_type {};
+
+  // При Hashed каждое поддерево левого дерева хранит сумму хешей своих пар,
+  // что ускоряет operator== и diff. std::hash должен быть согласован с
+  // компараторами: равные по ним элементы обязаны иметь равные хеши.
+  static_assert(!Hashed ||
+                    (is_hashable<left_t>::value && is_hashable<right_t>::value),
+                "Hashed bimap requires std::hash for Left and Right");
+
   template <bool Type>
   using type_tree_iter =
       std::conditional_t<Type, left_tree_iter, right_tree_iter>;
@@ -74,9 +96,11 @@ public:
   bimap(bimap&& other) noexcept
       : left_tree(std::move(static_cast<CompareLeft&>(other.left_tree))),
         right_tree(std::move(static_cast<CompareRight&>(other.right_tree))),
-        cnt_elem(other.cnt_elem) {
-    left_tree.root.swap(other.left_tree.root);
-    right_tree.root.swap(other.right_tree.root);
+        cnt_elem(std::exchange(other.cnt_elem, 0)) {
+    left_tree.root.right = &right_tree.root;
+    right_tree.root.right = &left_tree.root;
+    left_tree.swap_nodes(other.left_tree);
+    right_tree.swap_nodes(other.right_tree);
   }
 
   bimap& operator=(bimap const& other) {
@@ -131,6 +155,87 @@ private:
     }
   }
 
+  template <bool Type>
+  auto const& get_tree() const noexcept {
+    if constexpr (Type) {
+      return left_tree;
+    } else {
+      return right_tree;
+    }
+  }
+
+  template <bool Type>
+  std::vector<std::pair<base_it<Type>, base_it<Type>>>
+  partition(std::size_t parts) const {
+    std::vector<std::pair<base_it<Type>, base_it<Type>>> res;
+    for (auto const& range : get_tree<Type>().partition(parts)) {
+      res.emplace_back(base_it<Type>(range.first), base_it<Type>(range.second));
+    }
+    return res;
+  }
+
+  template <bool Type, typename F>
+  void for_each_parallel(F const& f, std::size_t threads) const {
+    auto ranges = partition<Type>(std::max<std::size_t>(threads, 1));
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(ranges.size());
+    for (auto const& range : ranges) {
+      tasks.push_back(std::async(std::launch::async, [&f, range] {
+        for (auto it = range.first; it != range.second; ++it) {
+          f(*it, *it.flip());
+        }
+      }));
+    }
+    for (auto& task : tasks) {
+      task.get();
+    }
+  }
+
+  // Количество и хеш пар со значением left строго между lo и hi,
+  // nullptr означает отсутствие границы.
+  std::pair<std::size_t, std::uint64_t>
+  summary_between(const left_t* lo, const left_t* hi) const noexcept {
+    auto res = hi ? left_tree.summary_before(*hi, false) : left_tree.summary();
+    if (lo) {
+      auto before = left_tree.summary_before(*lo, true);
+      res.first -= before.first;
+      res.second -= before.second;
+    }
+    return res;
+  }
+
+  // Вызывает f для пар из поддерева curr_node, которых нет в other.
+  // Поддерево содержит ровно пары с left из (lo, hi), поэтому оно
+  // пропускается целиком, если в other на этом интервале те же количество и
+  // хеш.
+  template <typename F>
+  void diff_subtree(bimap const& other, const node_base_t* curr_node,
+                    const left_t* lo, const left_t* hi, F const& f) const {
+    if (!curr_node) {
+      return;
+    }
+    if constexpr (Hashed) {
+      auto summary =
+          std::make_pair(curr_node->size, left_tree_t::subtree_hash(curr_node));
+      if (summary == other.summary_between(lo, hi)) {
+        return;
+      }
+    }
+    left_t const& left = static_cast<const left_node_t*>(curr_node)->value;
+    right_t const& right = *left_iterator(curr_node).flip();
+    diff_subtree(other, curr_node->left, lo, &left, f);
+    const node_base_t* other_node = other.left_tree.find(left);
+    if (!other_node ||
+        !right_tree.equal(right, *left_iterator(other_node).flip())) {
+      f(left, right);
+    }
+    diff_subtree(other, curr_node->right, &left, hi, f);
+  }
+
+  static std::size_t default_threads() noexcept {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
   template <typename LeftT, typename RightT>
   left_iterator insert_forward(LeftT&& left, RightT&& right) {
     if (left_tree.contains(left) || right_tree.contains(right)) {
@@ -138,6 +243,11 @@ private:
     }
     node_t* tmp =
         new node_t(std::forward<LeftT>(left), std::forward<RightT>(right));
+    if constexpr (Hashed) {
+      tmp->set_hash(node_details::mix_hash(
+          std::hash<left_t>()(static_cast<left_node_t*>(tmp)->value),
+          std::hash<right_t>()(static_cast<right_node_t*>(tmp)->value)));
+    }
     node_base_t* left_ptr = left_tree.insert(static_cast<left_node_t*>(tmp));
     right_tree.insert(static_cast<right_node_t*>(tmp));
     cnt_elem++;
@@ -296,6 +406,9 @@ public:
 
   // Возващает итератор на минимальный по порядку left.
   left_iterator begin_left() const {
+    if (!left_tree.root.left) {
+      return end_left();
+    }
     return left_iterator(node_base_t::get_min(left_tree.root.left));
   }
   // Возващает итератор на следующий за последним по порядку left.
@@ -305,6 +418,9 @@ public:
 
   // Возващает итератор на минимальный по порядку right.
   right_iterator begin_right() const {
+    if (!right_tree.root.left) {
+      return end_right();
+    }
     return right_iterator(node_base_t::get_min(right_tree.root.left));
   }
   // Возващает итератор на следующий за последним по порядку right.
@@ -312,6 +428,35 @@ public:
     return right_iterator(&right_tree.root);
   }
 
+  // Разбивает bimap на не более чем parts непересекающихся диапазонов
+  // [first, last) по порядку left (right), которые вместе покрывают все пары.
+  // Диапазоны в среднем примерно равны по размеру и могут обходиться
+  // независимо из разных потоков, пока bimap не изменяется.
+  std::vector<std::pair<left_iterator, left_iterator>>
+  partition_left(std::size_t parts) const {
+    return partition<true>(parts);
+  }
+  std::vector<std::pair<right_iterator, right_iterator>>
+  partition_right(std::size_t parts) const {
+    return partition<false>(parts);
+  }
+
+  // Параллельно вызывает f(left, right) (f(right, left)) для каждой пары,
+  // обходя диапазоны partition_left(threads) (partition_right(threads)) в
+  // отдельных потоках; threads == 0 обрабатывается как 1. f должен быть
+  // потокобезопасным и не изменять bimap.
+  // Исключение из f пробрасывается после завершения всех потоков.
+  template <typename F>
+  void for_each_parallel_left(F const& f,
+                              std::size_t threads = default_threads()) const {
+    for_each_parallel<true>(f, threads);
+  }
+  template <typename F>
+  void for_each_parallel_right(F const& f,
+                               std::size_t threads = default_threads()) const {
+    for_each_parallel<false>(f, threads);
+  }
+
   // Проверка на пустоту
   bool empty() const {
     return size() == 0;
@@ -330,6 +475,11 @@ public:
     if (a.size() != b.size()) {
       return false;
     }
+    if constexpr (Hashed) {
+      if (a.left_tree.summary() != b.left_tree.summary()) {
+        return false;
+      }
+    }
     for (auto it_a = a.begin_left(), it_b = b.begin_left();
          it_a != a.end_left() && it_b != b.end_left(); ++it_a, ++it_b) {
       if (!a.left_tree.equal(*it_a, *it_b) ||
@@ -342,4 +492,19 @@ public:
   friend bool operator!=(bimap const& a, bimap const& b) {
     return !(a == b);
   }
+
+  // Вызывает removed(left, right) для каждой пары из a, которой нет в b, и
+  // added(left, right) для каждой пары из b, которой нет в a, по порядку left.
+  // При Hashed совпадающие части не обходятся, и время работы пропорционально
+  // числу различий, умноженному на log^2(n); пропуск основан на 64-битном
+  // хеше, поэтому различие может быть потеряно с вероятностью коллизии.
+  template <typename OnRemoved, typename OnAdded>
+  friend void diff(bimap const& a, bimap const& b, OnRemoved const& removed,
+                   OnAdded const& added) {
+    if (&a == &b) {
+      return;
+    }
+    a.diff_subtree(b, a.left_tree.root.left, nullptr, nullptr, removed);
+    b.diff_subtree(a, b.left_tree.root.left, nullptr, nullptr, added);
+  }
 };
@@ -2,12 +2,15 @@
 
 #include "node.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace cartesian_tree {
 
-template <typename T, typename Compare, bool Type>
+template <typename T, typename Compare, bool Type, bool Hashed = false>
 struct treap : Compare {
   using node_base_t = node_details::node_base_t;
-  using node_value_t = node_details::node_ptr_t<T, Type>;
+  using node_value_t = node_details::node_ptr_t<T, Type, Hashed>;
 
   node_base_t root;
 
@@ -67,13 +70,35 @@ struct treap : Compare {
 
   void swap(treap& other) noexcept {
     std::swap(static_cast<Compare&>(*this), static_cast<Compare&>(other));
-    root.swap(other.root);
+    swap_nodes(other);
+  }
+
+  // Обменивает только элементы: ссылка корня на парное дерево остается на
+  // месте, а отцом вершины дерева становится свой корень.
+  void swap_nodes(treap& other) noexcept {
+    std::swap(root.left, other.root.left);
+    root.update_left_father();
+    other.root.update_left_father();
   }
 
   bool equal(T const& lhs, T const& rhs) const noexcept {
     return !Compare::operator()(lhs, rhs) && !Compare::operator()(rhs, lhs);
   }
 
+  static std::uint64_t subtree_hash(const node_base_t* node) noexcept {
+    return node ? static_cast<const node_value_t*>(node)->subtree_hash : 0;
+  }
+
+  static void update_subtree(node_base_t* node) noexcept {
+    node->update_subtree();
+    if constexpr (Hashed) {
+      node_value_t* value_node = static_cast<node_value_t*>(node);
+      value_node->subtree_hash = value_node->self_hash +
+                                 subtree_hash(node->left) +
+                                 subtree_hash(node->right);
+    }
+  }
+
   std::pair<node_base_t*, node_base_t*> split(node_base_t* curr_root,
                                               T const& value) noexcept {
     if (!curr_root) {
@@ -84,11 +109,13 @@ struct treap : Compare {
       auto treaps = split(curr_root->right, value);
       curr_root->right = treaps.first;
       curr_root->update_father();
+      update_subtree(curr_root);
       return {curr_root, treaps.second};
     } else {
       auto treaps = split(curr_root->left, value);
       curr_root->left = treaps.second;
       curr_root->update_father();
+      update_subtree(curr_root);
       return {treaps.first, curr_root};
     }
   }
@@ -103,10 +130,12 @@ struct treap : Compare {
     if (first->priority > second->priority) {
       first->right = merge(first->right, second);
       first->update_father();
+      update_subtree(first);
       return first;
     } else {
       second->left = merge(first, second->left);
       second->update_father();
+      update_subtree(second);
       return second;
     }
   }
@@ -129,7 +158,7 @@ struct treap : Compare {
       treaps2 = split(treaps1.second, *it_last);
     }
     root.left = merge(treaps1.first, treaps2.second);
-    root.update_father();
+    root.update_left_father();
     return treaps2.first;
   }
 
@@ -157,10 +186,15 @@ struct treap : Compare {
     if (deleted_node->father->right &&
         deleted_node == deleted_node->father->right) {
       deleted_node->father->right = tmp_node_value;
+      deleted_node->father->update_right_father();
     } else {
       deleted_node->father->left = tmp_node_value;
+      deleted_node->father->update_left_father();
+    }
+    for (node_base_t* curr_node = deleted_node->father; curr_node != &root;
+         curr_node = curr_node->father) {
+      update_subtree(curr_node);
     }
-    deleted_node->father->update_father();
     return {res, true};
   }
 
@@ -191,6 +225,79 @@ struct treap : Compare {
     }
     return iterator(&root);
   }
+  // Разбивает дерево на не более чем parts непересекающихся диапазонов
+  // [first, last) примерно равного размера, покрывающих все элементы по
+  // порядку. Границы ищутся по размерам поддеревьев за
+  // O(min(parts, n) * log(n)).
+  std::vector<std::pair<iterator, iterator>> partition(std::size_t parts) const {
+    std::vector<std::pair<iterator, iterator>> res;
+    if (!root.left || parts == 0) {
+      return res;
+    }
+    std::size_t cnt = root.left->size;
+    parts = std::min(parts, cnt);
+    res.reserve(parts);
+    const node_base_t* first = node_base_t::get_min(root.left);
+    for (std::size_t i = 1; i < parts; ++i) {
+      const node_base_t* pivot =
+          select(root.left, i * (cnt / parts) + std::min(i, cnt % parts));
+      res.emplace_back(iterator(first), iterator(pivot));
+      first = pivot;
+    }
+    res.emplace_back(iterator(first), iterator(&root));
+    return res;
+  }
+
+  // Возвращает элемент, перед которым в поддереве ровно index элементов.
+  static const node_base_t* select(const node_base_t* curr_node,
+                                   std::size_t index) noexcept {
+    while (curr_node) {
+      std::size_t left_size = curr_node->left ? curr_node->left->size : 0;
+      if (index < left_size) {
+        curr_node = curr_node->left;
+      } else if (index == left_size) {
+        return curr_node;
+      } else {
+        index -= left_size + 1;
+        curr_node = curr_node->right;
+      }
+    }
+    return nullptr;
+  }
+
+  // Количество и сумма хешей всех элементов дерева (только при Hashed).
+  std::pair<std::size_t, std::uint64_t> summary() const noexcept {
+    if (!root.left) {
+      return {0, 0};
+    }
+    return {root.left->size, subtree_hash(root.left)};
+  }
+
+  // Количество и сумма хешей элементов, меньших value (не больших value, если
+  // inclusive).
+  std::pair<std::size_t, std::uint64_t>
+  summary_before(T const& value, bool inclusive) const noexcept {
+    std::pair<std::size_t, std::uint64_t> res = {0, 0};
+    const node_base_t* curr_node = root.left;
+    while (curr_node) {
+      T const& curr_value = static_cast<const node_value_t*>(curr_node)->value;
+      bool before = inclusive ? !Compare::operator()(value, curr_value)
+                              : Compare::operator()(curr_value, value);
+      if (before) {
+        if (curr_node->left) {
+          res.first += curr_node->left->size;
+          res.second += subtree_hash(curr_node->left);
+        }
+        res.first++;
+        res.second += static_cast<const node_value_t*>(curr_node)->self_hash;
+        curr_node = curr_node->right;
+      } else {
+        curr_node = curr_node->left;
+      }
+    }
+    return res;
+  }
+
   iterator upper_bound(node_base_t* curr_node, T const& value) const noexcept {
     iterator res = lower_bound(curr_node, value);
     if (res.current_element != &root && equal(*res, value)) {
@@ -1,10 +1,25 @@
 #include "node.h"
 
+namespace {
+std::uint64_t splitmix64(std::uint64_t value) noexcept {
+  value += 0x9e3779b97f4a7c15;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+} // namespace
+
+std::uint64_t node_details::mix_hash(std::uint64_t first,
+                                     std::uint64_t second) noexcept {
+  return splitmix64(splitmix64(first) ^ second);
+}
+
 void node_details::node_base_t::swap(node_details::node_base_t& other) {
   std::swap(left, other.left);
   std::swap(right, other.right);
   std::swap(father, other.father);
   std::swap(priority, other.priority);
+  std::swap(size, other.size);
 }
 
 void node_details::node_base_t::update_father() noexcept {
@@ -63,3 +78,7 @@ void node_details::node_base_t::update_left_father() noexcept {
     left->father = this;
   }
 }
+
+void node_details::node_base_t::update_subtree() noexcept {
+  size = 1 + (left ? left->size : 0) + (right ? right->size : 0);
+}
@@ -1,17 +1,22 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <ctime>
 #include <random>
 #include <utility>
 
 namespace node_details {
 inline std::mt19937_64 rand_generator(time(nullptr));
 
+std::uint64_t mix_hash(std::uint64_t first, std::uint64_t second) noexcept;
+
 struct node_base_t {
   node_base_t* left = nullptr;
   node_base_t* right = nullptr;
   node_base_t* father = nullptr;
   std::uint64_t priority;
+  std::size_t size = 1;
 
   explicit node_base_t() : priority(rand_generator()) {}
   void swap(node_base_t& other);
@@ -19,6 +24,7 @@ struct node_base_t {
   void update_father() noexcept;
   void update_left_father() noexcept;
   void update_right_father() noexcept;
+  void update_subtree() noexcept;
 
   static const node_base_t* get_min(const node_base_t* curr_root) noexcept;
   static const node_base_t* get_max(const node_base_t* curr_root) noexcept;
@@ -26,8 +32,24 @@ struct node_base_t {
   static const node_base_t* prev(const node_base_t* curr_root) noexcept;
 };
 
-template <typename T, bool Type>
-struct node_ptr_t : node_base_t {
+template <bool Hashed>
+struct node_hash_t {
+  void swap(node_hash_t&) noexcept {}
+};
+
+template <>
+struct node_hash_t<true> {
+  std::uint64_t self_hash = 0;
+  std::uint64_t subtree_hash = 0;
+
+  void swap(node_hash_t& other) noexcept {
+    std::swap(self_hash, other.self_hash);
+    std::swap(subtree_hash, other.subtree_hash);
+  }
+};
+
+template <typename T, bool Type, bool Hashed = false>
+struct node_ptr_t : node_base_t, node_hash_t<Hashed> {
   T value;
 
   template <typename ValueT>
@@ -35,35 +57,42 @@ struct node_ptr_t : node_base_t {
 
   void swap(node_ptr_t& other) {
     node_base_t::swap(static_cast<node_base_t&>(other));
+    node_hash_t<Hashed>::swap(static_cast<node_hash_t<Hashed>&>(other));
     std::swap(value, other.value);
   }
 };
 
-template <typename Key, typename Value>
-struct node_t : node_ptr_t<Key, true>, node_ptr_t<Value, false> {
+// Хеши хранятся только в левой половине: их читает лишь левое дерево.
+template <typename Key, typename Value, bool Hashed = false>
+struct node_t : node_ptr_t<Key, true, Hashed>, node_ptr_t<Value, false> {
+  template <bool Type>
+  using side_t = node_ptr_t<std::conditional_t<Type, Key, Value>, Type,
+                            Type && Hashed>;
+
   template <typename Left, typename Right>
   explicit node_t(Left&& key, Right&& value)
-      : node_ptr_t<Key, true>(std::forward<Left>(key)),
-        node_ptr_t<Value, false>(std::forward<Right>(value)) {}
+      : side_t<true>(std::forward<Left>(key)),
+        side_t<false>(std::forward<Right>(value)) {}
+
+  void set_hash(std::uint64_t hash) noexcept {
+    side_t<true>::self_hash = hash;
+    side_t<true>::subtree_hash = hash;
+  }
 
   void swap(node_t& other) noexcept {
-    node_ptr_t<Key, true>::swap(static_cast<node_ptr_t<Key, true>&>(other));
-    node_ptr_t<Value, false>::swap(
-        static_cast<node_ptr_t<Value, false>&>(other));
+    side_t<true>::swap(static_cast<side_t<true>&>(other));
+    side_t<false>::swap(static_cast<side_t<false>&>(other));
   }
 
   template <bool Type>
   static const node_base_t* get_another_node(const node_base_t* node) {
-    using AnotherTypeElem = std::conditional_t<Type, Value, Key>;
     return static_cast<const node_base_t*>(
-        static_cast<const node_ptr_t<AnotherTypeElem, !Type>*>(
-            get_node_t<Type>(node)));
+        static_cast<const side_t<!Type>*>(get_node_t<Type>(node)));
   }
 
   template <bool Type>
   static const node_t* get_node_t(const node_base_t* node) {
-    using TypeElem = std::conditional_t<Type, Key, Value>;
-    return static_cast<const node_t*>(static_cast<const node_ptr_t<TypeElem, Type>*>(node));
+    return static_cast<const node_t*>(static_cast<const side_t<Type>*>(node));
   }
 };
 } // namespace node_details
@@ -0,0 +1,175 @@
+#include "../bimap.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+using pairs_t = std::vector<std::pair<int, int>>;
+
+std::mt19937 gen(12345);
+
+int rand_int(int bound) {
+  return std::uniform_int_distribution<int>(0, bound - 1)(gen);
+}
+
+// Эталон: left -> right и right -> left.
+struct model_t {
+  std::map<int, int> left_to_right;
+  std::map<int, int> right_to_left;
+
+  void insert(int left, int right) {
+    if (left_to_right.count(left) || right_to_left.count(right)) {
+      return;
+    }
+    left_to_right[left] = right;
+    right_to_left[right] = left;
+  }
+  void erase_left(int left) {
+    auto it = left_to_right.find(left);
+    if (it != left_to_right.end()) {
+      right_to_left.erase(it->second);
+      left_to_right.erase(it);
+    }
+  }
+  void erase_right(int right) {
+    auto it = right_to_left.find(right);
+    if (it != right_to_left.end()) {
+      left_to_right.erase(it->second);
+      right_to_left.erase(it);
+    }
+  }
+};
+
+pairs_t expected_removed(model_t const& a, model_t const& b) {
+  pairs_t res;
+  for (auto const& [left, right] : a.left_to_right) {
+    auto it = b.left_to_right.find(left);
+    if (it == b.left_to_right.end() || it->second != right) {
+      res.emplace_back(left, right);
+    }
+  }
+  return res;
+}
+
+// Применяет одну случайную операцию и к bimap, и к эталону.
+template <typename Bimap>
+void mutate(Bimap& map, model_t& model, int bound) {
+  int left = rand_int(bound);
+  int right = rand_int(bound);
+  int lo = std::min(left, right);
+  int hi = std::max(left, right);
+  switch (rand_int(7)) {
+  case 0:
+  case 1:
+    map.insert(left, right);
+    model.insert(left, right);
+    break;
+  case 2:
+    map.erase_left(left);
+    model.erase_left(left);
+    break;
+  case 3:
+    map.erase_right(right);
+    model.erase_right(right);
+    break;
+  case 4: {
+    auto it = map.find_left(left);
+    if (it != map.end_left()) {
+      map.erase_left(it);
+      model.erase_left(left);
+    }
+    break;
+  }
+  case 5: {
+    auto it = map.find_right(right);
+    if (it != map.end_right()) {
+      map.erase_right(it);
+      model.erase_right(right);
+    }
+    break;
+  }
+  case 6:
+    // Диапазон, начинающийся с end(), erase не поддерживает.
+    if (rand_int(2)) {
+      if (map.lower_bound_left(lo) == map.end_left()) {
+        break;
+      }
+      map.erase_left(map.lower_bound_left(lo), map.lower_bound_left(hi));
+      for (auto it = model.left_to_right.lower_bound(lo);
+           it != model.left_to_right.end() && it->first < hi;) {
+        model.right_to_left.erase(it->second);
+        it = model.left_to_right.erase(it);
+      }
+    } else {
+      if (map.lower_bound_right(lo) == map.end_right()) {
+        break;
+      }
+      map.erase_right(map.lower_bound_right(lo), map.lower_bound_right(hi));
+      for (auto it = model.right_to_left.lower_bound(lo);
+           it != model.right_to_left.end() && it->first < hi;) {
+        model.left_to_right.erase(it->second);
+        it = model.right_to_left.erase(it);
+      }
+    }
+    break;
+  }
+}
+
+template <typename Bimap>
+void check(Bimap const& a, Bimap const& b, model_t const& model_a,
+           model_t const& model_b) {
+  pairs_t removed;
+  pairs_t added;
+  diff(
+      a, b, [&](int left, int right) { removed.emplace_back(left, right); },
+      [&](int left, int right) { added.emplace_back(left, right); });
+  CHECK(removed == expected_removed(model_a, model_b));
+  CHECK(added == expected_removed(model_b, model_a));
+  CHECK((a == b) == (model_a.left_to_right == model_b.left_to_right));
+}
+
+template <typename Bimap>
+void run(int iterations, int bound, int max_steps) {
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    Bimap a;
+    model_t model_a;
+    for (int i = 0; i < bound; ++i) {
+      mutate(a, model_a, bound);
+    }
+    Bimap b(a);
+    model_t model_b = model_a;
+    int steps = rand_int(max_steps);
+    for (int i = 0; i < steps; ++i) {
+      if (rand_int(2)) {
+        mutate(a, model_a, bound);
+      } else {
+        mutate(b, model_b, bound);
+      }
+      check(a, b, model_a, model_b);
+    }
+  }
+}
+} // namespace
+
+int main() {
+  run<bimap<int, int, std::less<int>, std::less<int>, true>>(200, 1000, 256);
+  run<bimap<int, int, std::less<int>, std::less<int>, true>>(2000, 64, 8);
+  run<bimap<int, int>>(500, 64, 8);
+
+  // Пары с одинаковым хешем при прежнем смешивании.
+  bimap<int, int, std::less<int>, std::less<int>, true> a;
+  bimap<int, int, std::less<int>, std::less<int>, true> b;
+  a.insert(240, 79);
+  b.insert(237, 301);
+  std::size_t cnt = 0;
+  diff(
+      a, b, [&](int, int) { ++cnt; }, [&](int, int) { ++cnt; });
+  CHECK(cnt == 2);
+
+  std::puts("ok");
+}
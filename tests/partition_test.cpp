@@ -0,0 +1,180 @@
+#include "../bimap.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+using map_t = bimap<int, int>;
+
+std::mt19937 gen(4321);
+
+int rand_int(int bound) {
+  return std::uniform_int_distribution<int>(0, bound - 1)(gen);
+}
+
+// Диапазоны идут по порядку, не пересекаются, покрывают все элементы и
+// отличаются по размеру не более чем на один.
+template <typename It>
+void check_ranges(std::vector<std::pair<It, It>> const& ranges, It begin,
+                  It end, std::size_t size, std::size_t parts) {
+  std::size_t expected = std::min(parts, size);
+  CHECK(ranges.size() == expected);
+  if (expected == 0) {
+    return;
+  }
+  CHECK(ranges.front().first == begin);
+  CHECK(ranges.back().second == end);
+  std::size_t min_len = size;
+  std::size_t max_len = 0;
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    if (i > 0) {
+      CHECK(ranges[i - 1].second == ranges[i].first);
+    }
+    auto len = static_cast<std::size_t>(
+        std::distance(ranges[i].first, ranges[i].second));
+    min_len = std::min(min_len, len);
+    max_len = std::max(max_len, len);
+  }
+  CHECK(min_len > 0);
+  CHECK(max_len - min_len <= 1);
+}
+
+void check_partitions(map_t const& map) {
+  std::size_t size = map.size();
+  for (std::size_t parts :
+       {std::size_t(0), std::size_t(1), std::size_t(2), std::size_t(3),
+        std::size_t(7), size, size + 1, SIZE_MAX}) {
+    check_ranges(map.partition_left(parts), map.begin_left(), map.end_left(),
+                 size, parts);
+    check_ranges(map.partition_right(parts), map.begin_right(),
+                 map.end_right(), size, parts);
+  }
+}
+
+// Параллельный обход посещает каждую пару ровно один раз.
+void check_for_each(map_t const& map) {
+  for (std::size_t threads : {0, 1, 3, 16}) {
+    std::mutex mutex;
+    std::vector<std::pair<int, int>> left_seen;
+    std::vector<std::pair<int, int>> right_seen;
+    map.for_each_parallel_left(
+        [&](int left, int right) {
+          std::lock_guard<std::mutex> lock(mutex);
+          left_seen.emplace_back(left, right);
+        },
+        threads);
+    map.for_each_parallel_right(
+        [&](int right, int left) {
+          std::lock_guard<std::mutex> lock(mutex);
+          right_seen.emplace_back(left, right);
+        },
+        threads);
+    std::vector<std::pair<int, int>> expected;
+    for (auto it = map.begin_left(); it != map.end_left(); ++it) {
+      expected.emplace_back(*it, *it.flip());
+    }
+    std::sort(left_seen.begin(), left_seen.end());
+    std::sort(right_seen.begin(), right_seen.end());
+    CHECK(left_seen == expected);
+    CHECK(right_seen == expected);
+  }
+}
+
+void check_all(map_t const& map) {
+  check_partitions(map);
+  check_for_each(map);
+}
+} // namespace
+
+int main() {
+  map_t map;
+  check_all(map);
+
+  for (int i = 0; i < 1000; ++i) {
+    map.insert(rand_int(2000), rand_int(2000));
+  }
+  check_all(map);
+
+  for (int i = 0; i < 300; ++i) {
+    if (rand_int(2)) {
+      map.erase_left(rand_int(2000));
+    } else {
+      map.erase_right(rand_int(2000));
+    }
+  }
+  check_all(map);
+
+  auto left_it = map.begin_left();
+  std::advance(left_it, 10);
+  map.erase_left(left_it);
+  auto right_it = map.begin_right();
+  std::advance(right_it, 20);
+  map.erase_right(right_it);
+  check_all(map);
+
+  map.erase_left(map.lower_bound_left(100), map.lower_bound_left(400));
+  check_all(map);
+  map.erase_right(map.lower_bound_right(1500), map.end_right());
+  check_all(map);
+  map.erase_left(map.begin_left(), map.end_left());
+  CHECK(map.empty());
+  check_all(map);
+
+  map.insert(1, 1);
+  check_all(map);
+
+  // Обмен и присваивания переносят вершины между деревьями разных bimap.
+  map_t a;
+  map_t b;
+  for (int i = 0; i < 200; ++i) {
+    a.insert(rand_int(1000), rand_int(1000));
+    b.insert(rand_int(1000), rand_int(1000));
+  }
+  map_t c;
+  c = a;
+  map_t d(std::move(a));
+  CHECK(a.empty());
+  check_all(a);
+  c.swap(d);
+  d = std::move(b);
+  b = c;
+  for (map_t* curr : {&a, &b, &c, &d}) {
+    check_all(*curr);
+    if (!curr->empty()) {
+      curr->erase_left(curr->begin_left());
+      curr->erase_right(std::prev(curr->end_right()));
+    }
+    curr->insert(5000, 5000);
+    check_all(*curr);
+    curr->erase_left(curr->begin_left(), curr->end_left());
+    check_all(*curr);
+  }
+
+  map_t large;
+  for (int i = 0; i < 100; ++i) {
+    large.insert(i, -i);
+  }
+  bool thrown = false;
+  try {
+    large.for_each_parallel_left(
+        [](int left, int) {
+          if (left == 42) {
+            throw std::runtime_error("stop");
+          }
+        },
+        4);
+  } catch (std::runtime_error const&) {
+    thrown = true;
+  }
+  CHECK(thrown);
+
+  std::puts("ok");
+}